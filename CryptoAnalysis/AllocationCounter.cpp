@@ -0,0 +1,49 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<bool> counting{ false };
+	std::atomic<std::uint64_t> allocationCount{ 0 };
+	std::atomic<std::uint64_t> allocationBytes{ 0 };
+}
+
+void AllocationCounter::setEnabled(bool enable)
+{
+	counting.store(enable, std::memory_order_relaxed);
+}
+
+std::uint64_t AllocationCounter::allocations()
+{
+	return allocationCount.load(std::memory_order_relaxed);
+}
+
+std::uint64_t AllocationCounter::allocatedBytes()
+{
+	return allocationBytes.load(std::memory_order_relaxed);
+}
+
+// Array and nothrow forms of new and delete forward to these by default
+void* operator new(std::size_t size)
+{
+	if (counting.load(std::memory_order_relaxed))
+	{
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+		allocationBytes.fetch_add(size, std::memory_order_relaxed);
+	}
+	if (void* ptr = std::malloc(size != 0 ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+// Totals of allocations made through global operator new since program
+// start, which is replaced in AllocationCounter.cpp to count them. Qt
+// strings and containers allocate with malloc directly, so they are not
+// included and should be judged by peak memory usage instead. Counting
+// is disabled by default, so that it costs a single flag check
+namespace AllocationCounter
+{
+	void setEnabled(bool enable);
+	std::uint64_t allocations();
+	std::uint64_t allocatedBytes();
+}
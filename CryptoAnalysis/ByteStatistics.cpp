@@ -0,0 +1,264 @@
+#include "ByteStatistics.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	constexpr signed char BASE64_SKIP = -1;
+	constexpr signed char BASE64_PADDING = -2;
+
+	constexpr std::array<signed char, 256> makeBase64Values()
+	{
+		std::array<signed char, 256> values{};
+		for (int i = 0; i < 256; ++i)
+			values[i] = BASE64_SKIP;
+		for (int i = 0; i < 26; ++i)
+			values['A' + i] = i, values['a' + i] = 26 + i;
+		for (int i = 0; i < 10; ++i)
+			values['0' + i] = 52 + i;
+		values['+'] = 62;
+		values['/'] = 63;
+		values['='] = BASE64_PADDING;
+		return values;
+	}
+
+	constexpr std::array<signed char, 256> BASE64_VALUES = makeBase64Values();
+
+	constexpr int popCount(unsigned value)
+	{
+		int count = 0;
+		for (; value != 0; value &= value - 1)
+			++count;
+		return count;
+	}
+}
+
+std::size_t Base64Decoder::decode(const char* in, std::size_t size,
+	unsigned char* out)
+{
+	std::size_t written = 0;
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		const signed char value = BASE64_VALUES[(unsigned char)in[i]];
+		if (value == BASE64_PADDING)
+			reset(); // Leftover bits of the quantum are always zero
+		else if (value != BASE64_SKIP)
+		{
+			bits = bits << 6 | value;
+			bitCount += 6;
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				out[written++] = (bits >> bitCount) & 0xFF;
+			}
+		}
+	}
+	return written;
+}
+
+ByteStatistics::ByteStatistics()
+	: subPairs(SUB_PAIR_MATRICES * PAIR_VALUES), pairs(PAIR_VALUES)
+{
+	reset();
+}
+
+void ByteStatistics::reset()
+{
+	for (auto& subHistogram : subHistograms)
+		subHistogram.fill(0);
+	std::fill(std::begin(subPairs), std::end(subPairs), 0);
+	bytes.fill(0);
+	std::fill(std::begin(pairs), std::end(pairs), 0);
+	pendingBytes = 0;
+	total = 0;
+	lastByte = 0;
+}
+
+void ByteStatistics::feed(const unsigned char* data, std::size_t size)
+{
+	if (size == 0)
+		return;
+	if (total == 0) // The first byte doesn't finish any pair
+	{
+		++subHistograms[0][data[0]];
+		lastByte = data[0];
+		++total, ++pendingBytes;
+		++data, --size;
+	}
+	while (size > 0)
+	{
+		const std::size_t block = (std::size_t)std::min<std::uint64_t>(
+			size, FLUSH_BYTES - pendingBytes);
+		feedBlock(data, block);
+		data += block, size -= block;
+		total += block, pendingBytes += block;
+		if (pendingBytes == FLUSH_BYTES)
+			flush();
+	}
+}
+
+void ByteStatistics::feedBlock(const unsigned char* data, std::size_t size)
+{
+	std::uint32_t* const pairs0 = subPairs.data();
+	std::uint32_t* const pairs1 = pairs0 + PAIR_VALUES;
+	unsigned prev = lastByte;
+	std::size_t i = 0;
+	for (; i + 4 <= size; i += 4)
+	{
+		const unsigned b0 = data[i], b1 = data[i + 1],
+			b2 = data[i + 2], b3 = data[i + 3];
+		++subHistograms[0][b0];
+		++subHistograms[1][b1];
+		++subHistograms[2][b2];
+		++subHistograms[3][b3];
+		++pairs0[prev << 8 | b0];
+		++pairs1[b0 << 8 | b1];
+		++pairs0[b1 << 8 | b2];
+		++pairs1[b2 << 8 | b3];
+		prev = b3;
+	}
+	for (; i < size; ++i)
+	{
+		const unsigned b = data[i];
+		++subHistograms[0][b];
+		++pairs0[prev << 8 | b];
+		prev = b;
+	}
+	lastByte = prev;
+}
+
+void ByteStatistics::flush() const
+{
+	if (pendingBytes == 0)
+		return;
+	for (auto& subHistogram : subHistograms)
+		for (int i = 0; i < BYTE_VALUES; ++i)
+			bytes[i] += subHistogram[i], subHistogram[i] = 0;
+	for (int k = 0; k < SUB_PAIR_MATRICES; ++k)
+		for (int i = 0; i < PAIR_VALUES; ++i)
+		{
+			std::uint32_t& count = subPairs[k * PAIR_VALUES + i];
+			pairs[i] += count, count = 0;
+		}
+	pendingBytes = 0;
+}
+
+const ByteStatistics::Histogram& ByteStatistics::histogram() const
+{
+	flush();
+	return bytes;
+}
+
+const std::vector<std::uint64_t>& ByteStatistics::pairCounts() const
+{
+	flush();
+	return pairs;
+}
+
+double ByteStatistics::entropy() const
+{
+	double result = 0;
+	for (std::uint64_t count : histogram())
+		if (count != 0)
+		{
+			const double p = (double)count / total;
+			result -= p * std::log2(p);
+		}
+	return result;
+}
+
+double ByteStatistics::chiSquared() const
+{
+	if (total == 0)
+		return 0;
+	const double expected = (double)total / BYTE_VALUES;
+	double result = 0;
+	for (std::uint64_t count : histogram())
+		result += (count - expected) * (count - expected) / expected;
+	return result;
+}
+
+double ByteStatistics::chiSquaredPValue() const
+{
+	// Wilson-Hilferty approximation, which is very precise for such
+	// a large number of degrees of freedom
+	const double k = BYTE_VALUES - 1;
+	const double z = (std::cbrt(chiSquared() / k) - (1 - 2 / (9 * k)))
+		/ std::sqrt(2 / (9 * k));
+	return std::erfc(z / std::sqrt(2.0)) / 2;
+}
+
+double ByteStatistics::mean() const
+{
+	if (total == 0)
+		return 0;
+	double sum = 0;
+	const Histogram& counts = histogram();
+	for (int i = 0; i < BYTE_VALUES; ++i)
+		sum += (double)i * counts[i];
+	return sum / total;
+}
+
+double ByteStatistics::serialCorrelation() const
+{
+	const double n = total > 0 ? total - 1.0 : 0; // Number of pairs
+	if (n < 2)
+		return 0;
+	double sx = 0, sxx = 0, sy = 0, syy = 0, sxy = 0;
+	const std::vector<std::uint64_t>& counts = pairCounts();
+	for (int x = 0; x < BYTE_VALUES; ++x)
+		for (int y = 0; y < BYTE_VALUES; ++y)
+		{
+			const double count = (double)counts[x * BYTE_VALUES + y];
+			sx += x * count, sxx += x * x * count;
+			sy += y * count, syy += y * y * count;
+			sxy += x * y * count;
+		}
+	const double denominator = (n * sxx - sx * sx) * (n * syy - sy * sy);
+	// Correlation of constant sequence is undefined
+	if (denominator <= 0)
+		return std::numeric_limits<double>::quiet_NaN();
+	return (n * sxy - sx * sy) / std::sqrt(denominator);
+}
+
+std::uint64_t ByteStatistics::bitOnes() const
+{
+	std::uint64_t ones = 0;
+	const Histogram& counts = histogram();
+	for (int i = 0; i < BYTE_VALUES; ++i)
+		ones += counts[i] * popCount(i);
+	return ones;
+}
+
+std::uint64_t ByteStatistics::bitRuns() const
+{
+	if (total == 0)
+		return 0;
+	// Each run but the first one starts at a transition between bits,
+	// either inside a byte or between the LSB and the next byte's MSB
+	std::uint64_t transitions = 0;
+	const Histogram& counts = histogram();
+	for (int i = 0; i < BYTE_VALUES; ++i)
+		transitions += counts[i] * popCount((i ^ i >> 1) & 0x7F);
+	const std::vector<std::uint64_t>& pairMatrix = pairCounts();
+	for (int x = 0; x < BYTE_VALUES; ++x)
+		for (int y = 0; y < BYTE_VALUES; ++y)
+			if ((x & 1) != (y >> 7))
+				transitions += pairMatrix[x * BYTE_VALUES + y];
+	return transitions + 1;
+}
+
+double ByteStatistics::bitRunsPValue() const
+{
+	if (total == 0)
+		return 0;
+	const double n = 8.0 * total;
+	const double pi = bitOnes() / n;
+	// Runs test is not applicable if frequency test already fails
+	if (std::abs(pi - 0.5) >= 2 / std::sqrt(n))
+		return 0;
+	const double expected = 2 * n * pi * (1 - pi);
+	return std::erfc(std::abs(bitRuns() - expected)
+		/ (2 * std::sqrt(2 * n) * pi * (1 - pi)));
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Incremental base64 decoder which can be fed arbitrary-sized pieces of
+// encoded text. Characters outside of base64 alphabet (e.g. line breaks)
+// are skipped, and padding finishes current quantum, so concatenated
+// encodings (like several CipherAES outputs in one file) decode correctly
+class Base64Decoder
+{
+public:
+	// Maximum number of bytes decode() may write for given input size
+	static constexpr std::size_t maxDecodedSize(std::size_t encodedSize)
+	{
+		return encodedSize / 4 * 3 + 3;
+	}
+
+	// Decodes input into out and returns the number of bytes written
+	std::size_t decode(const char* in, std::size_t size, unsigned char* out);
+	void reset() { bits = 0, bitCount = 0; }
+
+private:
+	std::uint32_t bits = 0;
+	int bitCount = 0;
+};
+
+// Streaming accumulator of byte-level statistics, used to check binary
+// ciphertext for deviations from uniform randomness. Only the byte
+// histogram and the byte-pair matrix are updated while feeding data,
+// all the tests are derived from them afterwards
+class ByteStatistics
+{
+public:
+	static constexpr int BYTE_VALUES = 256;
+	static constexpr int PAIR_VALUES = BYTE_VALUES * BYTE_VALUES;
+
+	using Histogram = std::array<std::uint64_t, BYTE_VALUES>;
+
+	ByteStatistics();
+
+	void reset();
+	void feed(const unsigned char* data, std::size_t size);
+
+	std::uint64_t byteCount() const { return total; }
+	const Histogram& histogram() const;
+	// Row-major matrix, element [first * BYTE_VALUES + second]
+	const std::vector<std::uint64_t>& pairCounts() const;
+
+	// Shannon entropy in bits per byte (8 for uniform data)
+	double entropy() const;
+	// Chi-squared statistic of byte histogram against uniform
+	// distribution (255 degrees of freedom) and its upper tail p-value
+	double chiSquared() const;
+	double chiSquaredPValue() const;
+	// Arithmetic mean of bytes (127.5 for uniform data)
+	double mean() const;
+	// Lag-1 serial correlation coefficient of consecutive bytes
+	double serialCorrelation() const;
+	// Number of runs of identical bits (MSB first) and p-value of the
+	// runs test from NIST SP 800-22
+	std::uint64_t bitRuns() const;
+	double bitRunsPValue() const;
+
+private:
+	// Sub-counters are 32-bit, so they are flushed before they can overflow
+	static constexpr std::uint64_t FLUSH_BYTES = std::uint64_t(1) << 30;
+	static constexpr int SUB_HISTOGRAMS = 4;
+	static constexpr int SUB_PAIR_MATRICES = 2;
+
+	void feedBlock(const unsigned char* data, std::size_t size);
+	void flush() const;
+	std::uint64_t bitOnes() const;
+
+	// Consecutive increments of the same counter stall on store-to-load
+	// forwarding, which is typical for weak ciphertext (runs of one byte),
+	// so they are spread between several interleaved sub-counters
+	mutable std::array<std::array<std::uint32_t, BYTE_VALUES>,
+		SUB_HISTOGRAMS> subHistograms;
+	mutable std::vector<std::uint32_t> subPairs;
+	mutable std::uint64_t pendingBytes;
+	mutable Histogram bytes;
+	mutable std::vector<std::uint64_t> pairs;
+	std::uint64_t total;
+	unsigned lastByte;
+};
@@ -0,0 +1,160 @@
+#include "CorpusComparison.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <utility>
+
+CorpusComparison::CorpusComparison(const TextStatistics& textStats)
+	: textStats(textStats), rowSize(0), documents(0)
+{
+	for (int n = 1; n <= MAX_ORDER; ++n)
+	{
+		dimensions[n - 1] = textStats.nGramCount(n);
+		offsets[n - 1] = rowSize;
+		rowSize += dimensions[n - 1];
+	}
+}
+
+double CorpusComparison::requiredMemory(int documentCount) const
+{
+	// Frequencies are counted by TextStatistics in a temporary row of ints
+	return sizeof(float) * ((documentCount + 1.0) * rowSize
+		+ (double)MAX_ORDER * documentCount * documentCount);
+}
+
+void CorpusComparison::addDocument(QStringView text)
+{
+	vectors.resize(vectors.size() + rowSize);
+	textStats.nGramFrequencies(text, MAX_ORDER,
+		vectors.data() + (size_t)documents * rowSize);
+	++documents;
+}
+
+int CorpusComparison::tileCount() const
+{
+	const int blocks = (documents + DOCUMENT_BLOCK - 1) / DOCUMENT_BLOCK;
+	return blocks * (blocks + 1) / 2;
+}
+
+template<typename Term>
+void CorpusComparison::sumTile(int n, int firstBlock, int secondBlock,
+	Term term, TileSums& sums) const
+{
+	const size_t vectorSize = dimension(n);
+	const int firstBegin = firstBlock * DOCUMENT_BLOCK,
+		firstEnd = std::min(firstBegin + DOCUMENT_BLOCK, documents);
+	const int secondBegin = secondBlock * DOCUMENT_BLOCK,
+		secondEnd = std::min(secondBegin + DOCUMENT_BLOCK, documents);
+	for (auto& row : sums)
+		std::fill(std::begin(row), std::end(row), 0.0);
+
+	for (size_t k0 = 0; k0 < vectorSize; k0 += DIMENSION_BLOCK)
+	{
+		const size_t k1 = std::min(k0 + DIMENSION_BLOCK, vectorSize);
+		for (int i = firstBegin; i < firstEnd; ++i)
+		{
+			const float* p = frequencies(i, n);
+			// Only the upper triangle of diagonal tiles is needed
+			for (int j = std::max(secondBegin, i + 1); j < secondEnd; ++j)
+			{
+				const float* q = frequencies(j, n);
+				double sum = 0;
+				for (size_t k = k0; k < k1; ++k)
+					sum += term(p[k], q[k]);
+				sums[i - firstBegin][j - secondBegin] += sum;
+			}
+		}
+	}
+}
+
+std::vector<float> CorpusComparison::distances(int n, Metric metric,
+	int threads, Progress* progress) const
+{
+	const size_t vectorSize = dimension(n);
+	std::vector<float> result((size_t)documents * documents);
+	std::vector<double> norms;
+	if (metric == Metric::Cosine)
+		for (int i = 0; i < documents; ++i)
+		{
+			const float* p = frequencies(i, n);
+			double sum = 0;
+			for (size_t k = 0; k < vectorSize; ++k)
+				sum += (double)p[k] * p[k];
+			norms.push_back(std::sqrt(sum));
+		}
+
+	const int blocks = (documents + DOCUMENT_BLOCK - 1) / DOCUMENT_BLOCK;
+	std::vector<std::pair<int, int>> tiles;
+	for (int i = 0; i < blocks; ++i)
+		for (int j = i; j < blocks; ++j)
+			tiles.emplace_back(i, j);
+
+	// Tiles differ in cost (diagonal ones are half-empty), so they are
+	// distributed dynamically
+	std::atomic<size_t> nextTile{ 0 };
+	auto cancelled = [progress]() {
+		return progress && progress->cancelled.load(std::memory_order_relaxed);
+	};
+	auto worker = [&]() {
+		TileSums sums;
+		for (size_t t; !cancelled() && (t = nextTile++) < tiles.size(); )
+		{
+			const auto [firstBlock, secondBlock] = tiles[t];
+			switch (metric)
+			{
+			case Metric::Cosine:
+				sumTile(n, firstBlock, secondBlock, [](float p, float q) {
+					return (double)p * q;
+				}, sums);
+				break;
+			case Metric::ChiSquared:
+				sumTile(n, firstBlock, secondBlock, [](float p, float q) {
+					const double s = (double)p + q;
+					return s > 0 ? (p - q) * (p - q) / s : 0.0;
+				}, sums);
+				break;
+			case Metric::JensenShannon:
+				sumTile(n, firstBlock, secondBlock, [](float p, float q) {
+					const double s = (double)p + q;
+					return (p > 0 ? p * std::log2(2 * p / s) : 0.0)
+						+ (q > 0 ? q * std::log2(2 * q / s) : 0.0);
+				}, sums);
+				break;
+			}
+
+			const int firstBegin = firstBlock * DOCUMENT_BLOCK,
+				secondBegin = secondBlock * DOCUMENT_BLOCK;
+			for (int i = firstBegin; i < std::min(firstBegin
+				+ DOCUMENT_BLOCK, documents); ++i)
+				for (int j = std::max(secondBegin, i + 1); j < std::min(
+					secondBegin + DOCUMENT_BLOCK, documents); ++j)
+				{
+					const double sum = sums[i - firstBegin][j - secondBegin];
+					double distance = sum;
+					if (metric == Metric::Cosine)
+						distance = norms[i] * norms[j] > 0
+							? std::max(1 - sum / (norms[i] * norms[j]), 0.0) : 1;
+					else if (metric == Metric::JensenShannon)
+						distance = std::max(sum / 2, 0.0);
+					result[(size_t)i * documents + j] =
+						result[(size_t)j * documents + i] = (float)distance;
+				}
+			if (progress)
+				progress->tilesDone.fetch_add(1, std::memory_order_relaxed);
+		}
+	};
+
+	// Reserved beforehand, since allocation failure after threads have
+	// started would terminate the program
+	std::vector<std::thread> workers;
+	workers.reserve(std::max(threads, 1));
+	for (int t = 1; t < std::min<int>(threads, tiles.size()); ++t)
+		workers.emplace_back(worker);
+	worker();
+	for (std::thread& thread : workers)
+		thread.join();
+	if (cancelled())
+		return {};
+	return result;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "TextStatistics.h"
+#include <array>
+#include <atomic>
+#include <vector>
+
+// Pairwise distances between n-gram frequency vectors of many documents,
+// for every n-gram order up to MAX_ORDER. Vectors are dense and stored
+// contiguously, one row (with vectors of all orders) per document
+class CorpusComparison
+{
+public:
+	static constexpr int MAX_ORDER = 3;
+
+	enum class Metric
+	{
+		Cosine,        // 1 - cosine similarity, in [0, 1]
+		ChiSquared,    // Symmetric, sum of (p - q)^2 / (p + q), in [0, 2]
+		JensenShannon  // Jensen-Shannon divergence in bits, in [0, 1]
+	};
+
+	// Lets another thread follow and cancel distances() computation
+	struct Progress
+	{
+		std::atomic<int> tilesDone{ 0 };
+		std::atomic<bool> cancelled{ false };
+	};
+
+	// Alphabet of textStats shouldn't change while it's used here
+	explicit CorpusComparison(const TextStatistics& textStats);
+
+	// Approximate memory in bytes needed to compare documentCount
+	// documents, i.e. for their vectors and distance matrices of all
+	// orders. It grows fast with alphabet size, so it should be checked
+	// before adding documents
+	double requiredMemory(int documentCount) const;
+	void reserve(int documentCount)
+	{
+		vectors.reserve((size_t)documentCount * rowSize);
+	}
+	void addDocument(QStringView text);
+	int documentCount() const { return documents; }
+	size_t dimension(int n) const { return dimensions[n - 1]; }
+	const float* frequencies(int document, int n) const
+	{
+		return vectors.data() + (size_t)document * rowSize + offsets[n - 1];
+	}
+
+	// Number of tiles of a single distances() call, which are reported
+	// to its progress as they are done
+	int tileCount() const;
+	// Symmetric documentCount x documentCount matrix of distances between
+	// n-gram vectors in row-major order, or empty one if cancelled
+	std::vector<float> distances(int n, Metric metric, int threads,
+		Progress* progress = nullptr) const;
+
+private:
+	// Distances are computed by tiles of document pairs and, inside them,
+	// by slices of dimensions, so that vector slices of both document
+	// blocks of a tile stay in cache
+	static constexpr int DOCUMENT_BLOCK = 16;
+	static constexpr int DIMENSION_BLOCK = 2048;
+
+	using TileSums = double[DOCUMENT_BLOCK][DOCUMENT_BLOCK];
+
+	template<typename Term>
+	void sumTile(int n, int firstBlock, int secondBlock, Term term,
+		TileSums& sums) const;
+
+	const TextStatistics& textStats;
+	std::array<size_t, MAX_ORDER> dimensions;
+	std::array<size_t, MAX_ORDER> offsets;
+	size_t rowSize;
+	int documents;
+	std::vector<float> vectors;
+};
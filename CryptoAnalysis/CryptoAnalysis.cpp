@@ -1,16 +1,26 @@
+#include <QEventLoop>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QInputDialog>
 #include <QMessageBox>
+#include <QProgressDialog>
 #include <QTextStream>
+#include <QTimer>
+#include <QtWidgets/QApplication>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
 
 #include "CryptoAnalysis.h"
+#include "Profiler.h"
 
 CryptoAnalysis::CryptoAnalysis(QWidget *parent)
-    : QMainWindow(parent), collator(QLocale(QLocale::Ukrainian, QLocale::Ukraine)),
-	caseSensitive(false)
+    : QMainWindow(parent), collator(QLocale(QLocale::Ukrainian, QLocale::Ukraine))
 {
     ui.setupUi(this);
-	ui.caseSensitiveCheckBox->setChecked(caseSensitive);
+	ui.caseSensitiveCheckBox->setChecked(false);
 	ui.alphabetLE->setText(UKRAINIAN_ALPHABET);
 
     connect(ui.actionOpenPlaintext, &QAction::triggered,
@@ -21,7 +31,25 @@ CryptoAnalysis::CryptoAnalysis(QWidget *parent)
 		[this]() {sFileSave(false); });
 	connect(ui.actionSaveCiphertext, &QAction::triggered,
 		[this]() {sFileSave(true); });
+	connect(ui.actionAnalyzeBinary, &QAction::triggered,
+		[this]() {sAnalyzeBinaryFile(false); });
+	connect(ui.actionAnalyzeBase64, &QAction::triggered,
+		[this]() {sAnalyzeBinaryFile(true); });
+	connect(ui.actionCompareCorpus, &QAction::triggered,
+		this, &CryptoAnalysis::sCompareCorpus);
+	connect(ui.actionExportDistanceMatrix, &QAction::triggered,
+		this, &CryptoAnalysis::sExportDistanceMatrix);
+	connect(ui.corpusOrderCB,
+		QOverload<int>::of(&QComboBox::currentIndexChanged), [this]() {
+		if (!corpusNames.isEmpty())
+			displayCorpusComparison(); });
 	connect(ui.actionExit, &QAction::triggered, this, &QWidget::close);
+	connect(ui.actionEnableProfiling, &QAction::toggled,
+		[](bool checked) {Profiler::setEnabled(checked); });
+	connect(ui.actionExportTrace, &QAction::triggered,
+		this, &CryptoAnalysis::sExportTrace);
+	Profiler::setRunFinishedCallback([this](const Profiler::Run&) {
+		ui.statusBar->showMessage(Profiler::summary()); });
 
 	connect(ui.analyzePlaintextPB, &QPushButton::clicked,
 		this, &CryptoAnalysis::analyze);
@@ -75,75 +103,348 @@ void CryptoAnalysis::sFileSave(bool cipherText)
 	file.close();
 }
 
+void CryptoAnalysis::sAnalyzeBinaryFile(bool base64)
+{
+	const QString path = QFileDialog::getOpenFileName(this,
+		tr("Analyze file"), "", base64
+		? tr("Text files (*.txt);;All files (*)") : tr("All files (*)"));
+	if (path.isEmpty())
+		return;
+
+	QFile file(path);
+	file.open(QFile::ReadOnly);
+	if (!file.isOpen())
+	{
+		QMessageBox::critical(this, tr("Error"), tr("Error opening file"));
+		return;
+	}
+
+	// File is streamed, so it doesn't have to fit into memory
+	constexpr int progressSteps = 1000;
+	const qint64 fileSize = file.size();
+	QProgressDialog progress(tr("Analyzing file..."), tr("Cancel"),
+		0, progressSteps, this);
+	progress.setWindowModality(Qt::WindowModal);
+
+	ByteStatistics stats;
+	Base64Decoder decoder;
+	QByteArray chunk(BINARY_CHUNK_SIZE, Qt::Uninitialized);
+	std::vector<unsigned char> decoded(base64
+		? Base64Decoder::maxDecodedSize(BINARY_CHUNK_SIZE) : 0);
+	qint64 readSize;
+	while ((readSize = file.read(chunk.data(), chunk.size())) > 0)
+	{
+		if (base64)
+			stats.feed(decoded.data(), decoder.decode(
+				chunk.constData(), readSize, decoded.data()));
+		else
+			stats.feed(reinterpret_cast<const unsigned char*>(
+				chunk.constData()), readSize);
+		if (fileSize > 0)
+			progress.setValue(file.pos() * progressSteps / fileSize);
+		if (progress.wasCanceled())
+			return;
+	}
+	progress.reset();
+	if (readSize < 0)
+	{
+		QMessageBox::critical(this, tr("Error"), tr("Error reading file"));
+		return;
+	}
+	if (stats.byteCount() == 0)
+	{
+		QMessageBox::warning(this, tr("Invalid operation"),
+			tr("File is empty, nothing to analyze"));
+		return;
+	}
+
+	displayByteStatistics(stats);
+}
+
+void CryptoAnalysis::sCompareCorpus()
+{
+	if (!refreshAlphabet())
+		return;
+
+	bool ok;
+	// In the order of CorpusComparison::Metric
+	const QStringList metrics{ tr("Cosine distance"),
+		tr("Chi-squared distance"), tr("Jensen-Shannon divergence") };
+	const auto metric = static_cast<CorpusComparison::Metric>(
+		metrics.indexOf(QInputDialog::getItem(this, tr("Compare corpus"),
+		tr("Distance:"), metrics, 2, false, &ok)));
+	if (!ok)
+		return;
+
+	const QStringList documentPaths = QFileDialog::getOpenFileNames(this,
+		tr("Documents"), "", tr("Text files (*.txt);;All files (*)"));
+	if (documentPaths.isEmpty())
+		return;
+	QStringList baselinePaths;
+	if (QMessageBox::question(this, tr("Language identification"), tr(
+		"Choose baseline texts (e.g. of different languages) to find "
+		"the closest of them for each document?")) == QMessageBox::Yes)
+		baselinePaths = QFileDialog::getOpenFileNames(this,
+			tr("Baseline texts"), "", tr("Text files (*.txt);;All files (*)"));
+
+	// Texts are dropped right after their frequencies are computed
+	const QStringList paths = documentPaths + baselinePaths;
+	CorpusComparison comparison(textStats);
+	const double requiredMemory = comparison.requiredMemory(paths.size());
+	if (requiredMemory > MAX_CORPUS_MEMORY)
+	{
+		QMessageBox::warning(this, tr("Invalid operation"), tr(
+			"Comparing %1 documents over this alphabet needs about %2 MiB "
+			"of memory, which is more than the limit of %3 MiB. Use smaller "
+			"alphabet or fewer documents").arg(paths.size())
+			.arg(requiredMemory / (1 << 20), 0, 'f', 0)
+			.arg(MAX_CORPUS_MEMORY >> 20));
+		return;
+	}
+	auto outOfMemory = [this]() {
+		QMessageBox::critical(this, tr("Error"),
+			tr("Not enough memory to compare documents"));
+	};
+
+	QProgressDialog progress(tr("Reading documents..."), tr("Cancel"),
+		0, paths.size(), this);
+	progress.setWindowModality(Qt::WindowModal);
+	try
+	{
+		comparison.reserve(paths.size());
+		for (int i = 0; i < paths.size(); ++i)
+		{
+			QFile file(paths[i]);
+			file.open(QFile::ReadOnly | QFile::Text);
+			if (!file.isOpen())
+			{
+				QMessageBox::critical(this, tr("Error"),
+					tr("Error opening file %1").arg(paths[i]));
+				return;
+			}
+			comparison.addDocument(QTextStream(&file).readAll());
+			progress.setValue(i + 1);
+			if (progress.wasCanceled())
+				return;
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		progress.reset();
+		outOfMemory();
+		return;
+	}
+
+	// Distances of all orders are computed in the background, so that the
+	// window stays responsive and the comparison can be cancelled
+	constexpr int progressIntervalMs = 100;
+	CorpusComparison::Progress distancesProgress;
+	std::array<std::vector<float>, CorpusComparison::MAX_ORDER> distances;
+	std::atomic<bool> finished{ false };
+	// Exception escaping the thread would terminate the program, so
+	// allocation failure is reported back instead
+	bool failed = false;
+	std::thread worker([&]() {
+		const int threads =
+			std::max((int)std::thread::hardware_concurrency(), 1);
+		try
+		{
+			for (int n = 1; n <= CorpusComparison::MAX_ORDER; ++n)
+				distances[n - 1] = comparison.distances(n, metric, threads,
+					&distancesProgress);
+		}
+		catch (const std::bad_alloc&)
+		{
+			failed = true;
+		}
+		finished = true;
+	});
+	progress.setLabelText(tr("Comparing documents..."));
+	progress.setMinimumDuration(0);
+	progress.setMaximum(CorpusComparison::MAX_ORDER * comparison.tileCount());
+	progress.setValue(0);
+	connect(&progress, &QProgressDialog::canceled,
+		[&distancesProgress]() { distancesProgress.cancelled = true; });
+	QEventLoop loop;
+	QTimer timer;
+	connect(&timer, &QTimer::timeout, [&]() {
+		if (finished)
+			loop.quit();
+		else if (!distancesProgress.cancelled)
+			progress.setValue(distancesProgress.tilesDone);
+	});
+	timer.start(progressIntervalMs);
+	loop.exec();
+	worker.join();
+	progress.reset();
+	if (failed)
+	{
+		outOfMemory();
+		return;
+	}
+	if (distancesProgress.cancelled)
+		return;
+
+	corpusDistances = std::move(distances);
+	corpusNames.clear();
+	for (const QString& path : paths)
+		corpusNames.append(QFileInfo(path).fileName());
+	corpusBaselines = baselinePaths.size();
+	displayCorpusComparison();
+}
+
+void CryptoAnalysis::sExportDistanceMatrix()
+{
+	if (corpusNames.isEmpty())
+	{
+		QMessageBox::warning(this, tr("Invalid operation"),
+			tr("Nothing to export. Compare corpus first"));
+		return;
+	}
+	// Matrix of n-grams currently chosen for the plot is exported
+	const QString nGrams = ui.corpusOrderCB->currentText();
+	const std::vector<float>& distances =
+		corpusDistances[ui.corpusOrderCB->currentIndex()];
+	const QString path = QFileDialog::getSaveFileName(this,
+		tr("Export distance matrix of %1").arg(nGrams.toLower()), "",
+		tr("CSV files (*.csv);;All files (*)"));
+	if (path.isEmpty())
+		return;
+
+	QFile file(path);
+	file.open(QFile::WriteOnly | QFile::Text);
+	if (!file.isOpen())
+	{
+		QMessageBox::critical(this, tr("Error"), tr("Error saving to file"));
+		return;
+	}
+
+	auto quoted = [](QString str) {
+		return '"' + str.replace('"', "\"\"") + '"';
+	};
+	QTextStream textStream(&file);
+	textStream << quoted(nGrams);
+	for (const QString& name : corpusNames)
+		textStream << ',' << quoted(name);
+	textStream << '\n';
+	for (int i = 0; i < corpusNames.size(); ++i)
+	{
+		textStream << quoted(corpusNames[i]);
+		for (int j = 0; j < corpusNames.size(); ++j)
+			textStream << ',' << distances[i * corpusNames.size() + j];
+		textStream << '\n';
+	}
+	file.close();
+}
+
+void CryptoAnalysis::sExportTrace()
+{
+	if (Profiler::history().empty() && Profiler::paintHistory().empty())
+	{
+		QMessageBox::warning(this, tr("Invalid operation"), tr(
+			"Nothing to export. Enable profiling and run analysis first"));
+		return;
+	}
+	const QString path = QFileDialog::getSaveFileName(this,
+		tr("Export trace"), "", tr("Trace files (*.json);;All files (*)"));
+	if (path.isEmpty())
+		return;
+
+	QFile file(path);
+	file.open(QFile::WriteOnly);
+	if (!file.isOpen())
+	{
+		QMessageBox::critical(this, tr("Error"), tr("Error saving to file"));
+		return;
+	}
+
+	file.write(Profiler::chromeTrace());
+	file.close();
+}
+
 void CryptoAnalysis::analyze()
 {
-	QString text = (sender() == ui.analyzePlaintextPB
-		? ui.plaintextTE : ui.ciphertextTE)->toPlainText();
+	Profiler::Scope scope("analyze");
+	QString text;
+	{
+		Profiler::Scope textScope("toPlainText");
+		text = (sender() == ui.analyzePlaintextPB
+			? ui.plaintextTE : ui.ciphertextTE)->toPlainText();
+		textScope.addBytes(text.size() * sizeof(QChar));
+	}
+	scope.addBytes(text.size() * sizeof(QChar));
+	// Aborted analysis isn't a run, and its time would include the dialogs
 	if (text.isEmpty())
 	{
+		scope.discard();
 		QMessageBox::warning(this, tr("Invalid operation"),
 			tr("Text is empty, nothing to analyze"));
 		return;
 	}
 
 	if (!refreshAlphabet())
+	{
+		scope.discard();
 		return;
+	}
 
 	analyzeChars(text);
-	analyzeBigrams(text);
-	analyzeTrigrams(text);
+	if (text.size() >= 2)
+		analyzeBigrams(text);
+	if (text.size() >= 3)
+		analyzeTrigrams(text);
 	ui.bigramsMCP->update();
+
+	// Run is finished before the warnings, so that its time doesn't
+	// include them
+	scope.finish();
+	if (text.size() < 2)
+		QMessageBox::warning(this, tr("Invalid operation"),
+			tr("Text is too short and does not contain any bigrams"));
+	if (text.size() < 3)
+		QMessageBox::warning(this, tr("Invalid operation"),
+			tr("Text is too short and does not contain any trigrams"));
 }
 
 bool CryptoAnalysis::refreshAlphabet()
 {
-	caseSensitive = ui.caseSensitiveCheckBox->isChecked();
-	alphabet = ui.alphabetLE->text();
-	charIndex.clear();
-	for (int i = 0; i < alphabet.size(); ++i)
+	if (!textStats.setAlphabet(ui.alphabetLE->text(),
+		ui.caseSensitiveCheckBox->isChecked()))
 	{
-		const QChar ch = (caseSensitive ? alphabet[i] : alphabet[i].toLower());
-		if (charIndex.contains(ch))
-		{
-			QMessageBox::warning(this, tr("Invalid operation"), tr(
-				"Alphabet contains identical characters. "
-				"Note: if 'case sensitive' is false, check that you "
-				"don't include same letter in both upper and lower case"));
-			return false;
-		}
-		alphabet[i] = ch;
-		charIndex[ch] = i;
+		QMessageBox::warning(this, tr("Invalid operation"), tr(
+			"Alphabet contains identical characters. "
+			"Note: if 'case sensitive' is false, check that you "
+			"don't include same letter in both upper and lower case"));
+		return false;
 	}
 	// Now alphabet chars have (by convention) lower case if not caseSensitive
-	ui.alphabetLE->setText(alphabet);
+	ui.alphabetLE->setText(textStats.alphabet());
 	return true;
 }
 
-std::vector<int> CryptoAnalysis::getCharCounts(const QString& text)
+void CryptoAnalysis::analyzeChars(const QString& text)
 {
-	std::vector<int> charCounts(alphabet.size());
-	for (QChar ch : text)
+	Profiler::Scope scope("analyzeChars", text.size() * sizeof(QChar));
+	const QString& alphabet = textStats.alphabet();
+	std::vector<int> charCounts;
 	{
-		auto it = charIndex.find(caseSensitive ? ch : ch.toLower());
-		if (it != charIndex.end())
-			++charCounts[it.value()];
+		Profiler::Scope countScope("countChars", text.size() * sizeof(QChar));
+		charCounts = textStats.charCounts(text);
 	}
-	return charCounts;
-}
-
-void CryptoAnalysis::analyzeChars(const QString& text)
-{
-	auto charCounts = getCharCounts(text);
 	const int allChars = std::accumulate(std::begin(charCounts),
 		std::end(charCounts), 0);
 	FrequencyData charFreqs;
 	for (int i = 0; i < alphabet.size(); ++i)
 		charFreqs.emplace_back(alphabet[i], (qreal)charCounts[i] / allChars);
 
-	std::sort(std::begin(charFreqs), std::end(charFreqs),
-		[this](const auto& l, const auto& r) {
-		return collator.compare(l.first, r.first) < 0;
-	});
+	{
+		Profiler::Scope sortScope("sortAlphabetically",
+			charFreqs.size() * sizeof(FrequencyData::value_type));
+		std::sort(std::begin(charFreqs), std::end(charFreqs),
+			[this](const auto& l, const auto& r) {
+			return collator.compare(l.first, r.first) < 0;
+		});
+	}
 	displayBarChart(ui.charsLexChartView, charFreqs);
 
 	sortByFrequencyAndShrink(charFreqs, charFreqs.size());
@@ -153,23 +454,14 @@ void CryptoAnalysis::analyzeChars(const QString& text)
 
 void CryptoAnalysis::analyzeBigrams(const QString& text)
 {
-	if (text.size() < 2)
-	{
-		QMessageBox::warning(this, tr("Invalid operation"),
-			tr("Text is too short and does not contain any bigrams"));
-		return;
-	}
-
-	QHash<QString, int> bigramCounts;
-	int allBigrams = 0;
-	QChar c0 = (caseSensitive ? text[0] : text[0].toLower()), c1;
-	for (int i = 1; i < text.size(); ++i)
+	Profiler::Scope scope("analyzeBigrams", text.size() * sizeof(QChar));
+	const QString& alphabet = textStats.alphabet();
+	TextStatistics::NGramCounts bigrams;
 	{
-		c1 = (caseSensitive ? text[i] : text[i].toLower());
-		if (charIndex.contains(c0) && charIndex.contains(c1))
-			++bigramCounts[QString(c0).append(c1)], ++allBigrams;
-		c0 = c1;
+		Profiler::Scope countScope("countBigrams", text.size() * sizeof(QChar));
+		bigrams = textStats.bigramCounts(text);
 	}
+	auto& [bigramCounts, allBigrams] = bigrams;
 	FrequencyData bigramFreqs;
 	for (const QString& bigram : bigramCounts.keys())
 		bigramFreqs.emplace_back(bigram,
@@ -202,26 +494,13 @@ void CryptoAnalysis::analyzeBigrams(const QString& text)
 
 void CryptoAnalysis::analyzeTrigrams(const QString& text)
 {
-	if (text.size() < 3)
+	Profiler::Scope scope("analyzeTrigrams", text.size() * sizeof(QChar));
+	TextStatistics::NGramCounts trigrams;
 	{
-		QMessageBox::warning(this, tr("Invalid operation"),
-			tr("Text is too short and does not contain any trigrams"));
-		return;
-	}
-
-	QHash<QString, int> trigramCounts;
-	int allTrigrams = 0;
-	QChar c0 = (caseSensitive ? text[0] : text[0].toLower()),
-		  c1 = (caseSensitive ? text[1] : text[1].toLower()), c2;
-	for (int i = 2; i < text.size(); ++i)
-	{
-		c2 = (caseSensitive ? text[i] : text[i].toLower());
-		if (charIndex.contains(c0) && charIndex.contains(c1)
-			&& charIndex.contains(c2))
-			++trigramCounts[QString(c0).append(c1).append(c2)], ++allTrigrams;
-		c0 = c1;
-		c1 = c2;
+		Profiler::Scope countScope("countTrigrams", text.size() * sizeof(QChar));
+		trigrams = textStats.trigramCounts(text);
 	}
+	auto& [trigramCounts, allTrigrams] = trigrams;
 	FrequencyData trigramFreqs;
 	for (const QString& trigram : trigramCounts.keys())
 		trigramFreqs.emplace_back(trigram,
@@ -232,12 +511,127 @@ void CryptoAnalysis::analyzeTrigrams(const QString& text)
 	displayTable(ui.trigramsTableWidget, trigramFreqs, tr("Trigram"));
 }
 
+void CryptoAnalysis::displayByteStatistics(const ByteStatistics& stats)
+{
+	MatrixColorPlot::Axis axis(ByteStatistics::BYTE_VALUES);
+	for (int i = 0; i < ByteStatistics::BYTE_VALUES; ++i)
+		axis[i] = QString("%1").arg(i, 2, 16, QChar('0')).toUpper();
+
+	const ByteStatistics::Histogram& byteCounts = stats.histogram();
+	FrequencyData byteFreqs;
+	for (int i = 0; i < ByteStatistics::BYTE_VALUES; ++i)
+		byteFreqs.emplace_back(axis[i],
+			(qreal)byteCounts[i] / stats.byteCount());
+	displayBarChart(ui.bytesChartView, byteFreqs);
+
+	// Expected values are the ones of uniformly random data
+	const std::vector<std::tuple<QString, QString, QString>> tests{
+		{ tr("Bytes"), QString::number(stats.byteCount()), "" },
+		{ tr("Entropy (bits per byte)"),
+			QString::number(stats.entropy()), "8" },
+		{ tr("Chi-squared"), QString::number(stats.chiSquared()), "255" },
+		{ tr("Chi-squared p-value"),
+			QString::number(stats.chiSquaredPValue()), "> 0.01" },
+		{ tr("Arithmetic mean"), QString::number(stats.mean()), "127.5" },
+		{ tr("Serial correlation"),
+			QString::number(stats.serialCorrelation()), "0" },
+		{ tr("Bit runs"), QString::number(stats.bitRuns()),
+			QString::number(4.0 * stats.byteCount()) },
+		{ tr("Bit runs p-value"),
+			QString::number(stats.bitRunsPValue()), "> 0.01" }
+	};
+	ui.bytesTableWidget->setRowCount(tests.size());
+	ui.bytesTableWidget->setColumnCount(3);
+	ui.bytesTableWidget->setHorizontalHeaderLabels(
+		{ tr("Test"), tr("Value"), tr("Expected") });
+	for (int i = 0; i < tests.size(); ++i)
+	{
+		const auto& [name, value, expected] = tests[i];
+		ui.bytesTableWidget->setItem(i, 0, new QTableWidgetItem(name));
+		ui.bytesTableWidget->setItem(i, 1, new QTableWidgetItem(value));
+		ui.bytesTableWidget->setItem(i, 2, new QTableWidgetItem(expected));
+	}
+
+	const std::vector<std::uint64_t>& pairCounts = stats.pairCounts();
+	const std::uint64_t maxCount = std::max<std::uint64_t>(1,
+		*std::max_element(std::begin(pairCounts), std::end(pairCounts)));
+	MatrixColorPlot::Data matrixData(ByteStatistics::BYTE_VALUES);
+	for (int i = 0; i < ByteStatistics::BYTE_VALUES; ++i)
+	{
+		matrixData[i].resize(ByteStatistics::BYTE_VALUES);
+		for (int j = 0; j < ByteStatistics::BYTE_VALUES; ++j)
+			matrixData[i][j] = (qreal)pairCounts[
+				i * ByteStatistics::BYTE_VALUES + j] / maxCount;
+	}
+	ui.bigramsMCP->setXCaption(tr("Second byte"));
+	ui.bigramsMCP->setYCaption(tr("First byte"));
+	ui.bigramsMCP->setXLabels(axis);
+	ui.bigramsMCP->setYLabels(axis);
+	ui.bigramsMCP->setData(matrixData);
+	ui.bigramsMCP->adjustSize();
+	ui.bigramsMCP->update();
+
+	ui.statsTW->setCurrentWidget(ui.statsBytesTab);
+}
+
+void CryptoAnalysis::displayCorpusComparison()
+{
+	const int count = corpusNames.size(), documents = count - corpusBaselines;
+	const int order = ui.corpusOrderCB->currentIndex();
+	const std::vector<float>& distances = corpusDistances[order];
+	auto distance = [&distances, count](int i, int j) {
+		return distances[(size_t)i * count + j];
+	};
+
+	// Documents are labelled by their numbers, baselines additionally by B
+	MatrixColorPlot::Axis axis(count);
+	for (int i = 0; i < count; ++i)
+		axis[i] = (i < documents ? QString::number(i + 1)
+			: "B" + QString::number(i - documents + 1));
+	// Matrix is shown directly from corpusDistances, since it has count^2
+	// elements and may be very large
+	const float maxDistance = std::max(*std::max_element(
+		std::begin(distances), std::end(distances)), 1e-9f);
+	ui.corpusMCP->setXCaption(tr("Document"));
+	ui.corpusMCP->setYCaption(tr("Document"));
+	ui.corpusMCP->setXLabels(axis);
+	ui.corpusMCP->setYLabels(axis);
+	ui.corpusMCP->setValues([this, order, count, maxDistance](int i, int j) {
+		return corpusDistances[order][(size_t)i * count + j] / maxDistance;
+	});
+	ui.corpusMCP->adjustSize();
+	ui.corpusMCP->update();
+
+	// Each document is matched with the closest baseline, or with the
+	// closest other document if there are no baselines
+	const int candidatesBegin = (corpusBaselines != 0 ? documents : 0);
+	ui.corpusTableWidget->setRowCount(documents);
+	ui.corpusTableWidget->setColumnCount(3);
+	ui.corpusTableWidget->setHorizontalHeaderLabels(
+		{ tr("Document"), tr("Closest"), tr("Distance") });
+	for (int i = 0; i < documents; ++i)
+	{
+		int closest = -1;
+		for (int j = candidatesBegin; j < count; ++j)
+			if (j != i && (closest == -1 || distance(i, j) < distance(i, closest)))
+				closest = j;
+		ui.corpusTableWidget->setItem(i, 0, new QTableWidgetItem(
+			QString("%1. %2").arg(axis[i], corpusNames[i])));
+		ui.corpusTableWidget->setItem(i, 1, new QTableWidgetItem(closest == -1
+			? "" : QString("%1. %2").arg(axis[closest], corpusNames[closest])));
+		ui.corpusTableWidget->setItem(i, 2, new QTableWidgetItem(closest == -1
+			? "" : QString::number(distance(i, closest))));
+	}
+
+	ui.statsTW->setCurrentWidget(ui.statsCorpusTab);
+}
+
 void CryptoAnalysis::encrypt()
 {
 	if (!refreshAlphabet())
 		return;
 
-	const int m = alphabet.size();
+	const int m = textStats.alphabet().size();
 	int a = ui.aSB->value(), b = ui.bSB->value();
 	a %= m, b %= m;
 	if (std::gcd(a, m) != 1)
@@ -247,35 +641,12 @@ void CryptoAnalysis::encrypt()
 		return;
 	}
 
-	QString text = ui.plaintextTE->toPlainText();
-	for (QChar& ch : text)
-	{
-		const bool originalUpper = ch.isUpper();
-		QChar newCh = (caseSensitive ? ch : ch.toLower());
-		if (charIndex.contains(newCh))
-		{
-			newCh = alphabet[(a * charIndex[newCh] + b) % m];
-			if (!caseSensitive && originalUpper)
-				newCh = newCh.toUpper();
-			ch = newCh;
-		}
-	}
-	ui.ciphertextTE->setText(text);
+	ui.ciphertextTE->setText(textStats.affineEncrypt(
+		ui.plaintextTE->toPlainText(), a, b));
 }
 
 void CryptoAnalysis::decrypt()
 {
-	auto twoMaxFreqChars = [this](const QString& str) {
-		auto charCounts = getCharCounts(str);
-		int maxIdx = -1, preMaxIdx = -1;
-		for (int i = 0; i < alphabet.size(); ++i)
-			if (maxIdx == -1 || charCounts[i] > charCounts[maxIdx])
-				preMaxIdx = maxIdx, maxIdx = i;
-			else if (preMaxIdx == -1 || charCounts[i] > charCounts[preMaxIdx])
-				preMaxIdx = i;
-		return std::pair{ maxIdx, preMaxIdx };
-	};
-
 	refreshAlphabet();
 
 	QMessageBox::information(this, tr("Information"), tr(
@@ -294,56 +665,31 @@ void CryptoAnalysis::decrypt()
 	}
 
 	QString baseline = QTextStream(&baselineFile).readAll();
-	auto [baselineMax, baseLinePreMax] = twoMaxFreqChars(baseline);
-	if (baselineMax == -1 || baseLinePreMax == -1)
+	const auto baselineChars = textStats.twoMostFrequentChars(baseline);
+	if (baselineChars.first == -1 || baselineChars.second == -1)
 	{
 		QMessageBox::warning(this, tr("Invalid operation"), tr(
 			"Baseline is too short to perform auto-decrypt"));
 		return;
 	}
 	QString ciphertext = ui.ciphertextTE->toPlainText();
-	auto [ciphertextMax, ciphertextPreMax] = twoMaxFreqChars(ciphertext);
-	if (ciphertextMax == -1 || ciphertextPreMax == -1)
+	const auto ciphertextChars = textStats.twoMostFrequentChars(ciphertext);
+	if (ciphertextChars.first == -1 || ciphertextChars.second == -1)
 	{
 		QMessageBox::warning(this, tr("Invalid operation"), tr(
 			"Ciphertext is too short to perform auto-decrypt"));
 		return;
 	}
 
-	const int m = alphabet.size();
-	// We suppose that:
-	// a * baselineMax    + b == ciphertextMax    mod m
-	// a * baseLinePreMax + b == ciphertextPreMax mod m
-	int a, b;
-	for (a = 0; a < m; ++a)
-		if (std::gcd(a, m) == 1)
-		{
-			b = ((ciphertextMax - a * baselineMax) % m + m) % m;
-			if ((b + a * baseLinePreMax) % m == ciphertextPreMax)
-				break;
-		}
-	if (a == m) // If a != m, there was a break on some valid (a, b) pair
+	const auto key = textStats.findAffineKey(baselineChars, ciphertextChars);
+	if (!key)
 	{
 		QMessageBox::information(this, tr("Failure"), tr(
 			"Can't perform auto-decrypt"));
 		return;
 	}
-	// Since a is found, gcd(a, m) == 1, so a_inv will be found
-	int a_inv = 1;
-	for (; (a * a_inv) % m != 1; ++a_inv);
-	// Now decrypt according to this
-	for (QChar& ch : ciphertext)
-	{
-		const bool originalUpper = ch.isUpper();
-		QChar newCh = (caseSensitive ? ch : ch.toLower());
-		if (charIndex.contains(newCh))
-		{
-			newCh = alphabet[a_inv * (charIndex[newCh] - b + m) % m];
-			if (!caseSensitive && originalUpper)
-				newCh = newCh.toUpper();
-			ch = newCh;
-		}
-	}
+	const auto [a, b] = *key;
+	ciphertext = textStats.affineDecrypt(ciphertext, a, b);
 	QMessageBox::information(this, tr("Success"), tr(
 		"Successfully decrypted: a = %0, b = %1").arg(a).arg(b));
 	ui.aSB->setValue(a);
@@ -354,6 +700,8 @@ void CryptoAnalysis::decrypt()
 void CryptoAnalysis::sortByFrequencyAndShrink(FrequencyData& data,
 	size_t cnt) const
 {
+	Profiler::Scope scope("sortByFrequencyAndShrink",
+		data.size() * sizeof(FrequencyData::value_type));
 	const auto midIter = std::begin(data) + std::min(cnt, data.size());
 	std::partial_sort(std::begin(data), midIter, std::end(data),
 		[this](const auto& l, const auto& r) {
@@ -366,6 +714,8 @@ void CryptoAnalysis::sortByFrequencyAndShrink(FrequencyData& data,
 void CryptoAnalysis::displayBarChart(QChartView* chartView,
 	const FrequencyData& data)
 {
+	Profiler::Scope scope("displayBarChart",
+		data.size() * sizeof(FrequencyData::value_type));
 	QChart* chart = new QChart;
 	chart->setTheme(QChart::ChartThemeBlueCerulean);
 	QBarSeries* series = new QBarSeries;
@@ -398,6 +748,8 @@ void CryptoAnalysis::displayBarChart(QChartView* chartView,
 void CryptoAnalysis::displayTable(QTableWidget* table,
 	const FrequencyData& data, const QString& dataColumnName)
 {
+	Profiler::Scope scope("displayTable",
+		data.size() * sizeof(FrequencyData::value_type));
 	table->setRowCount(data.size());
 	table->setColumnCount(2);
 	table->setHorizontalHeaderLabels({ dataColumnName, tr("Frequency") });
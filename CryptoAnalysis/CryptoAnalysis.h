@@ -2,6 +2,9 @@
 
 #include <QtWidgets/QMainWindow>
 #include "ui_CryptoAnalysis.h"
+#include "ByteStatistics.h"
+#include "CorpusComparison.h"
+#include "TextStatistics.h"
 
 class CryptoAnalysis : public QMainWindow
 {
@@ -12,11 +15,20 @@ public:
     inline static const QString UKRAINIAN_ALPHABET
         = QString::fromWCharArray(L"賿");
 
+    // Binary files are read by chunks of this size
+    static constexpr qint64 BINARY_CHUNK_SIZE = 1 << 20;
+    // Corpus comparison isn't started if it would need more memory
+    static constexpr qint64 MAX_CORPUS_MEMORY = qint64(4) << 30;
+
     CryptoAnalysis(QWidget *parent = Q_NULLPTR);
 
 // public slots:
     void sFileOpen(bool cipherText);
     void sFileSave(bool cipherText);
+    void sAnalyzeBinaryFile(bool base64);
+    void sExportTrace();
+    void sCompareCorpus();
+    void sExportDistanceMatrix();
 
     void analyze();
     void encrypt();
@@ -28,15 +40,20 @@ private:
         const FrequencyData& data, const QString& dataColumnName);
 
     bool refreshAlphabet();
-    std::vector<int> getCharCounts(const QString&);
     void analyzeChars(const QString&);
+    // Text should contain at least 2 and 3 chars respectively
     void analyzeBigrams(const QString&);
     void analyzeTrigrams(const QString&);
+    void displayByteStatistics(const ByteStatistics& stats);
+    void displayCorpusComparison();
     void sortByFrequencyAndShrink(FrequencyData& data, size_t cnt) const;
 
     Ui::CryptoAnalysisClass ui;
     QCollator collator;
-    QString alphabet;
-    QHash<QChar, int> charIndex;
-    bool caseSensitive;
+    TextStatistics textStats;
+    // File names of the last compared documents followed by baselines
+    QStringList corpusNames;
+    int corpusBaselines = 0;
+    // Distance matrices for every n-gram order
+    std::array<std::vector<float>, CorpusComparison::MAX_ORDER> corpusDistances;
 };
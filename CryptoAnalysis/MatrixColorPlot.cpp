@@ -1,5 +1,7 @@
 #include "MatrixColorPlot.h"
+#include "Profiler.h"
 #include <QPainter>
+#include <algorithm>
 
 MatrixColorPlot::MatrixColorPlot(QWidget* parent)
 	: QWidget(parent)
@@ -17,6 +19,22 @@ MatrixColorPlot::~MatrixColorPlot()
 
 void MatrixColorPlot::paintEvent(QPaintEvent* paintEvent)
 {
+	Profiler::Scope scope("paintEvent", 0, Profiler::Category::Paint);
+	// Only tiles intersecting the repainted area are drawn, since matrices
+	// of large corpora are much bigger than the visible part of the widget
+	const QRect area = paintEvent->rect();
+	const int firstRow = std::max(0,
+		int((area.top() - TILES_START_Y) / TILE_SIZE));
+	const int lastRow = std::min((int)yLabels.size(),
+		int((area.bottom() - TILES_START_Y) / TILE_SIZE) + 1);
+	const int firstColumn = std::max(0,
+		int((area.left() - TILES_START_X) / TILE_SIZE));
+	const int lastColumn = std::min((int)xLabels.size(),
+		int((area.right() - TILES_START_X) / TILE_SIZE) + 1);
+	if (firstRow < lastRow && firstColumn < lastColumn)
+		scope.addBytes((lastRow - firstRow) * (lastColumn - firstColumn)
+			* sizeof(qreal));
+
 	QPainter painter(this);
 	painter.setBackground(Qt::white);
 	painter.setFont(QFont("Arial", 12));
@@ -30,22 +48,22 @@ void MatrixColorPlot::paintEvent(QPaintEvent* paintEvent)
 
 	painter.drawText(QRect(0, 0, width(), CAPTIONRECT_WIDTH),
 		Qt::AlignCenter, xCaption);
-	for (int i = 0; i < yLabels.size(); ++i)
+	for (int i = firstRow; i < lastRow; ++i)
 	{
 		painter.drawText(QRect(0, 0, LABEL_SIZE, TILE_SIZE).translated(
 			YLABELS_START_X, YLABELS_START_Y + i * TILE_SIZE),
 			Qt::AlignCenter, yLabels[i]);
 	}
-	for (int j = 0; j < xLabels.size(); ++j)
+	for (int j = firstColumn; j < lastColumn; ++j)
 	{
 		painter.drawText(QRect(0, 0, TILE_SIZE, LABEL_SIZE).translated(
 			XLABELS_START_X + j * TILE_SIZE, XLABELS_START_Y),
 			Qt::AlignCenter, yLabels[j]);
 	}
-	for (int i = 0; i < yLabels.size(); ++i)
-		for (int j = 0; j < xLabels.size(); ++j)
+	for (int i = firstRow; i < lastRow; ++i)
+		for (int j = firstColumn; j < lastColumn; ++j)
 		{
-			const int elem = data[i][j] * 255;
+			const int elem = (values ? values(i, j) : data[i][j]) * 255;
 			painter.setBrush(QColor(elem, elem, elem, 255));
 			painter.drawRect(QRect(0, 0, TILE_SIZE, TILE_SIZE).translated(
 				TILES_START_X + j * TILE_SIZE, TILES_START_Y + i * TILE_SIZE));
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QFrame>
+#include <functional>
 
 class MatrixColorPlot : public QWidget
 {
@@ -19,6 +20,8 @@ public:
 
 	using Axis = std::vector<QString>;
 	using Data = std::vector<std::vector<qreal>>;
+	// Value of the tile in row i and column j
+	using ValueAccessor = std::function<qreal(int i, int j)>;
 
 	void paintEvent(QPaintEvent* paintEvent) override;
 	QSize sizeHint() const override;
@@ -33,7 +36,19 @@ public:
 	void setYCaption(const QString& yC) { yCaption = yC; }
 	void setXLabels(const Axis& xL) { xLabels = xL; }
 	void setYLabels(const Axis& yL) { yLabels = yL; }
-	void setData(const Data& d) { data = d; }
+	void setData(const Data& d)
+	{
+		data = d;
+		values = nullptr;
+	}
+	// Alternative to setData for large matrices, which then aren't copied.
+	// Values should be in [0, 1], and the accessor should stay valid while
+	// they are shown
+	void setValues(ValueAccessor accessor)
+	{
+		data.clear();
+		values = std::move(accessor);
+	}
 
 private:
 	QString xCaption;
@@ -41,4 +56,5 @@ private:
 	Axis xLabels;
 	Axis yLabels;
 	Data data;
+	ValueAccessor values;
 };
@@ -0,0 +1,124 @@
+#include "Profiler.h"
+#include "AllocationCounter.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+
+namespace
+{
+	QString formatStage(const Profiler::Stage& stage)
+	{
+		return QString("%1 %2 ms").arg(stage.name)
+			.arg(stage.durationNs / 1e6, 0, 'f', 1);
+	}
+}
+
+void Profiler::Scope::begin(const char* name, quint64 bytes,
+	Category category)
+{
+	if (depth == 0)
+		currentCategory = category;
+	else if (category != currentCategory)
+		return;
+	startAllocations = AllocationCounter::allocations();
+	index = (int)currentRun.size();
+	currentRun.push_back({ name, depth++, std::chrono::duration_cast<
+		std::chrono::nanoseconds>(Clock::now() - startTime).count(),
+		0, bytes, 0 });
+}
+
+void Profiler::Scope::end()
+{
+	Stage& stage = currentRun[index];
+	stage.durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		Clock::now() - startTime).count() - stage.startNs;
+	stage.allocations = AllocationCounter::allocations() - startAllocations;
+	if (--depth != 0)
+		return;
+
+	const bool paint = (currentCategory == Category::Paint);
+	std::deque<Run>& finishedRuns = (paint ? paintRuns : runs);
+	finishedRuns.push_back(std::move(currentRun));
+	currentRun.clear();
+	if ((int)finishedRuns.size() > (paint ? PAINT_HISTORY_SIZE : HISTORY_SIZE))
+		finishedRuns.pop_front();
+	if (!paint && runFinished)
+		runFinished(runs.back());
+}
+
+void Profiler::Scope::discard()
+{
+	if (index == -1)
+		return;
+	// Nested scopes have already ended, so their stages are the last ones
+	currentRun.resize(index);
+	--depth;
+	index = -1;
+}
+
+void Profiler::setEnabled(bool enable)
+{
+	enabled = enable;
+	AllocationCounter::setEnabled(enable);
+}
+
+QString Profiler::summary()
+{
+	QStringList names, summaries;
+	for (auto it = runs.rbegin(); it != runs.rend(); ++it)
+	{
+		const Run& run = *it;
+		if (names.contains(run.front().name))
+			continue;
+		names.append(run.front().name);
+
+		QStringList substages;
+		for (const Stage& stage : run)
+			if (stage.depth == 1)
+				substages.append(formatStage(stage));
+		QString runSummary = QString("%1, %2 KiB, %3 operator new allocations")
+			.arg(formatStage(run.front()))
+			.arg(run.front().bytes / 1024).arg(run.front().allocations);
+		if (!substages.isEmpty())
+			runSummary += " (" + substages.join(", ") + ")";
+		summaries.prepend(runSummary);
+	}
+	return summaries.join(" | ");
+}
+
+QByteArray Profiler::chromeTrace()
+{
+	QJsonArray events;
+	auto appendHistory = [&events](const std::deque<Run>& history, int tid,
+		const char* threadName) {
+		events.append(QJsonObject{
+			{ "name", "thread_name" },
+			{ "ph", "M" },
+			{ "pid", 1 },
+			{ "tid", tid },
+			{ "args", QJsonObject{ { "name", threadName } } }
+		});
+		for (const Run& run : history)
+			for (const Stage& stage : run)
+				events.append(QJsonObject{
+					{ "name", stage.name },
+					{ "cat", "CryptoAnalysis" },
+					{ "ph", "X" },
+					{ "ts", stage.startNs / 1e3 },
+					{ "dur", stage.durationNs / 1e3 },
+					{ "pid", 1 },
+					{ "tid", tid },
+					{ "args", QJsonObject{
+						{ "bytes", (qint64)stage.bytes },
+						{ "operatorNewAllocations",
+							(qint64)stage.allocations } } }
+				});
+	};
+	appendHistory(runs, 1, "Analysis");
+	appendHistory(paintRuns, 2, "Paint");
+	return QJsonDocument(QJsonObject{
+		{ "traceEvents", events },
+		{ "displayTimeUnit", "ms" }
+	}).toJson();
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <vector>
+
+// Collects wall time, processed bytes and operator new allocations of
+// nested stages of the analysis. Stages are marked by Scope objects, and
+// every top-level one (with its nested stages) makes a run, kept in a
+// rolling history. Repaints happen on their own, often many times per
+// second, so their runs are kept apart to not push the analysis out.
+// While profiling is disabled, a scope costs a single flag check
+class Profiler
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	enum class Category
+	{
+		Analysis,
+		Paint
+	};
+
+	struct Stage
+	{
+		const char* name;
+		int depth;
+		qint64 startNs; // Since profiler start
+		qint64 durationNs;
+		quint64 bytes;
+		quint64 allocations; // Through operator new only
+	};
+	// Stages in order of their start, the first one is the top-level one
+	using Run = std::vector<Stage>;
+
+	class Scope
+	{
+	public:
+		// Category of a nested scope should match the one of its run,
+		// otherwise the scope isn't profiled (e.g. a repaint in an event
+		// loop of a dialog shown during analysis)
+		explicit Scope(const char* name, quint64 bytes = 0,
+			Category category = Category::Analysis)
+		{
+			if (enabled)
+				begin(name, bytes, category);
+		}
+		~Scope()
+		{
+			finish();
+		}
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		void addBytes(quint64 bytes)
+		{
+			if (index != -1)
+				currentRun[index].bytes += bytes;
+		}
+		// Ends the stage before the scope does, e.g. before showing a dialog
+		void finish()
+		{
+			if (index != -1)
+				end();
+			index = -1;
+		}
+		// Drops the stage with its nested ones, and the whole run if the
+		// stage is top-level, e.g. when the operation is aborted
+		void discard();
+
+	private:
+		void begin(const char* name, quint64 bytes, Category category);
+		void end();
+
+		int index = -1; // -1 if the stage isn't profiled
+		quint64 startAllocations;
+	};
+
+	static constexpr int HISTORY_SIZE = 100;
+	static constexpr int PAINT_HISTORY_SIZE = 100;
+
+	static bool isEnabled() { return enabled; }
+	// Allocations are counted only while profiling is enabled
+	static void setEnabled(bool enable);
+	static const std::deque<Run>& history() { return runs; }
+	static const std::deque<Run>& paintHistory() { return paintRuns; }
+	static void clearHistory()
+	{
+		runs.clear();
+		paintRuns.clear();
+	}
+	// Called after every finished analysis run, but not after paint ones
+	static void setRunFinishedCallback(std::function<void(const Run&)> callback)
+	{
+		runFinished = std::move(callback);
+	}
+
+	// Latest analysis run of every distinct top-level stage with times of
+	// its direct substages
+	static QString summary();
+	// Both histories in Chrome trace event format, loadable by trace
+	// viewers. Paint runs are shown as a separate thread
+	static QByteArray chromeTrace();
+
+private:
+	inline static bool enabled = false;
+	inline static const Clock::time_point startTime = Clock::now();
+	inline static int depth = 0;
+	inline static Category currentCategory = Category::Analysis;
+	inline static Run currentRun;
+	inline static std::deque<Run> runs;
+	inline static std::deque<Run> paintRuns;
+	inline static std::function<void(const Run&)> runFinished;
+};
@@ -0,0 +1,182 @@
+#include "TextStatistics.h"
+#include <numeric>
+
+bool TextStatistics::setAlphabet(const QString& alphabet, bool caseSensitive)
+{
+	this->caseSensitive = caseSensitive;
+	letters = alphabet;
+	charIndex.clear();
+	for (int i = 0; i < letters.size(); ++i)
+	{
+		const QChar ch = normalized(letters[i]);
+		if (charIndex.contains(ch))
+			return false;
+		letters[i] = ch;
+		charIndex[ch] = i;
+	}
+	return true;
+}
+
+int TextStatistics::indexOf(QChar ch) const
+{
+	return charIndex.value(normalized(ch), -1);
+}
+
+std::vector<int> TextStatistics::charCounts(QStringView text) const
+{
+	std::vector<int> counts(letters.size());
+	for (QChar ch : text)
+	{
+		auto it = charIndex.find(normalized(ch));
+		if (it != charIndex.end())
+			++counts[it.value()];
+	}
+	return counts;
+}
+
+TextStatistics::NGramCounts TextStatistics::bigramCounts(
+	QStringView text) const
+{
+	NGramCounts bigrams;
+	if (text.size() < 2)
+		return bigrams;
+	QChar c0 = normalized(text[0]), c1;
+	for (int i = 1; i < text.size(); ++i)
+	{
+		c1 = normalized(text[i]);
+		if (charIndex.contains(c0) && charIndex.contains(c1))
+			++bigrams.counts[QString(c0).append(c1)], ++bigrams.total;
+		c0 = c1;
+	}
+	return bigrams;
+}
+
+TextStatistics::NGramCounts TextStatistics::trigramCounts(
+	QStringView text) const
+{
+	NGramCounts trigrams;
+	if (text.size() < 3)
+		return trigrams;
+	QChar c0 = normalized(text[0]), c1 = normalized(text[1]), c2;
+	for (int i = 2; i < text.size(); ++i)
+	{
+		c2 = normalized(text[i]);
+		if (charIndex.contains(c0) && charIndex.contains(c1)
+			&& charIndex.contains(c2))
+			++trigrams.counts[QString(c0).append(c1).append(c2)],
+			++trigrams.total;
+		c0 = c1;
+		c1 = c2;
+	}
+	return trigrams;
+}
+
+qint64 TextStatistics::nGramCount(int n) const
+{
+	qint64 count = 1;
+	for (int i = 0; i < n; ++i)
+		count *= letters.size();
+	return count;
+}
+
+void TextStatistics::nGramFrequencies(QStringView text, int maxN,
+	float* frequencies) const
+{
+	const int m = letters.size();
+	const qint64 shiftedCount = nGramCount(maxN - 1);
+	std::vector<qint64> offsets(maxN + 1);
+	for (int n = 1; n <= maxN; ++n)
+		offsets[n] = offsets[n - 1] + nGramCount(n);
+	std::vector<int> counts(offsets[maxN]), totals(maxN);
+	// Index of the last maxN characters and length of the current sequence
+	// of alphabet characters (at most maxN). Index of the last n of them
+	// is its remainder modulo nGramCount(n). Only the last maxN - 1 chars
+	// are shifted, so that the index never exceeds nGramCount(maxN)
+	qint64 index = 0;
+	int length = 0;
+	for (QChar ch : text)
+	{
+		auto it = charIndex.find(normalized(ch));
+		if (it == charIndex.end())
+		{
+			length = 0;
+			continue;
+		}
+		index = index % shiftedCount * m + it.value();
+		if (length < maxN)
+			++length;
+		for (int n = 1; n <= length; ++n)
+			++counts[offsets[n - 1] + index % (offsets[n] - offsets[n - 1])],
+			++totals[n - 1];
+	}
+	for (int n = 1; n <= maxN; ++n)
+		for (qint64 i = offsets[n - 1]; i < offsets[n]; ++i)
+			frequencies[i] = totals[n - 1] != 0
+				? (float)counts[i] / totals[n - 1] : 0;
+}
+
+std::pair<int, int> TextStatistics::twoMostFrequentChars(
+	QStringView text) const
+{
+	const auto counts = charCounts(text);
+	int maxIdx = -1, preMaxIdx = -1;
+	for (int i = 0; i < letters.size(); ++i)
+		if (maxIdx == -1 || counts[i] > counts[maxIdx])
+			preMaxIdx = maxIdx, maxIdx = i;
+		else if (preMaxIdx == -1 || counts[i] > counts[preMaxIdx])
+			preMaxIdx = i;
+	return { maxIdx, preMaxIdx };
+}
+
+QString TextStatistics::affineEncrypt(QStringView text, int a, int b) const
+{
+	const int m = letters.size();
+	return affineTransform(text, a % m, b % m);
+}
+
+QString TextStatistics::affineDecrypt(QStringView text, int a, int b) const
+{
+	const int m = letters.size();
+	a %= m, b %= m;
+	int a_inv = 1;
+	for (; (a * a_inv) % m != 1 % m; ++a_inv);
+	// a_inv * (x - b) == a_inv * x + a_inv * (m - b) mod m
+	return affineTransform(text, a_inv, a_inv * (m - b) % m);
+}
+
+std::optional<std::pair<int, int>> TextStatistics::findAffineKey(
+	std::pair<int, int> plainChars, std::pair<int, int> cipherChars) const
+{
+	const int m = letters.size();
+	// We suppose that:
+	// a * plainChars.first  + b == cipherChars.first  mod m
+	// a * plainChars.second + b == cipherChars.second mod m
+	for (int a = 0; a < m; ++a)
+		if (std::gcd(a, m) == 1)
+		{
+			const int b = ((cipherChars.first - a * plainChars.first)
+				% m + m) % m;
+			if ((b + a * plainChars.second) % m == cipherChars.second)
+				return std::pair{ a, b };
+		}
+	return std::nullopt;
+}
+
+QString TextStatistics::affineTransform(QStringView text, int a, int b) const
+{
+	const int m = letters.size();
+	QString result = text.toString();
+	for (QChar& ch : result)
+	{
+		const bool originalUpper = ch.isUpper();
+		auto it = charIndex.find(normalized(ch));
+		if (it != charIndex.end())
+		{
+			QChar newCh = letters[(a * it.value() + b) % m];
+			if (!caseSensitive && originalUpper)
+				newCh = newCh.toUpper();
+			ch = newCh;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringView>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Frequency analysis and affine cipher over a letter alphabet, independent
+// of the user interface so that it can also be driven by the benchmark
+class TextStatistics
+{
+public:
+	struct NGramCounts
+	{
+		QHash<QString, int> counts;
+		int total = 0;
+	};
+
+	// Returns false if alphabet contains identical characters (if not
+	// caseSensitive, also the same letter in both upper and lower case)
+	bool setAlphabet(const QString& alphabet, bool caseSensitive);
+	// Alphabet chars have (by convention) lower case if not caseSensitive
+	const QString& alphabet() const { return letters; }
+	bool isCaseSensitive() const { return caseSensitive; }
+	// Index of the character in alphabet or -1 if it isn't there
+	int indexOf(QChar ch) const;
+
+	std::vector<int> charCounts(QStringView text) const;
+	NGramCounts bigramCounts(QStringView text) const;
+	NGramCounts trigramCounts(QStringView text) const;
+	// Number of distinct n-grams over the alphabet, which doesn't fit into
+	// int already for trigrams over large alphabets
+	qint64 nGramCount(int n) const;
+	// Dense frequencies of n-grams of every order from 1 to maxN, counted
+	// in a single pass and written one order after another. Each order is
+	// indexed by alphabet indices of n-gram characters taken as digits in
+	// base of alphabet size, so output should have nGramCount(1) + ... +
+	// nGramCount(maxN) elements. Frequencies of an order are zeros if text
+	// contains no n-grams of it
+	void nGramFrequencies(QStringView text, int maxN, float* frequencies) const;
+	// Alphabet indices of two most frequent characters, -1 if absent
+	std::pair<int, int> twoMostFrequentChars(QStringView text) const;
+
+	// Multiplier a should be coprime with alphabet size
+	QString affineEncrypt(QStringView text, int a, int b) const;
+	QString affineDecrypt(QStringView text, int a, int b) const;
+	// Finds key (a, b) of affine cipher, which maps the pair of plaintext
+	// character indices to the pair of ciphertext ones
+	std::optional<std::pair<int, int>> findAffineKey(
+		std::pair<int, int> plainChars, std::pair<int, int> cipherChars) const;
+
+private:
+	QChar normalized(QChar ch) const
+	{
+		return caseSensitive ? ch : ch.toLower();
+	}
+	QString affineTransform(QStringView text, int a, int b) const;
+
+	QString letters;
+	QHash<QChar, int> charIndex;
+	bool caseSensitive = false;
+};
@@ -0,0 +1,518 @@
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "AllocationCounter.h"
+#include "TextStatistics.h"
+
+// Qt 5 strings hold at most about 2^30 - 13 chars, so the largest
+// synthetic text is kept a little below that
+constexpr int MAX_SYNTHETIC_CHARS = (1 << 30) - (1 << 10);
+constexpr int MAX_THREADS = 1024;
+
+struct Options
+{
+	QString corpusDir = "../CryptoAnalysis";
+	int maxSyntheticChars = MAX_SYNTHETIC_CHARS;
+	std::vector<int> threadCounts;
+	int repetitions = 3;
+	double minSeconds = 0.5;
+	QString label;
+	QString outputPath;
+	QString baselinePath;
+	double tolerance = 0.1;
+};
+
+struct Input
+{
+	QString name;
+	QString alphabet;
+	bool caseSensitive;
+	QString text;
+	QString baseline; // Plaintext with known frequencies for auto-decrypt
+};
+
+struct Measurement
+{
+	int repetitions = 0;
+	double bestSeconds = 0;
+	double meanSeconds = 0;
+	// Only allocations through operator new, see AllocationCounter.h
+	std::uint64_t operatorNewAllocations = 0;
+	std::uint64_t operatorNewBytes = 0;
+};
+
+const QString UKRAINIAN_ALPHABET = QString::fromUtf16(
+	u"\u0430\u0431\u0432\u0433\u0491\u0434\u0435\u0454\u0436\u0437\u0438"
+	u"\u0456\u0457\u0439\u043a\u043b\u043c\u043d\u043e\u043f\u0440\u0441"
+	u"\u0442\u0443\u0444\u0445\u0446\u0447\u0448\u0449\u044c\u044e\u044f");
+const QString LATIN_ALPHABET = "abcdefghijklmnopqrstuvwxyz";
+const QString DIGITS_ALPHABET = "0123456789";
+constexpr int MIN_SYNTHETIC_CHARS = 1 << 20;
+constexpr int SYNTHETIC_SIZE_STEP = 32;
+constexpr int BASELINE_CHARS = 1 << 20;
+
+// Peak memory of the whole process so far, so for a single measurement only
+// its growth against the previous ones is meaningful
+std::uint64_t peakMemoryUsage()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return std::uint64_t(usage.ru_maxrss) * 1024;
+#endif
+}
+
+bool readCorpus(const QString& path, QString& text)
+{
+	QFile file(path);
+	file.open(QFile::ReadOnly | QFile::Text);
+	if (!file.isOpen())
+		return false;
+	// Bundled corpora are in the Windows Cyrillic code page
+	QTextStream textStream(&file);
+	textStream.setCodec("Windows-1251");
+	text = textStream.readAll();
+	return true;
+}
+
+// Letters have Zipf-like frequencies and are separated by spaces, so that
+// the text resembles natural language for the auto-decrypt attack
+QString syntheticText(const QString& alphabet, int size, unsigned seed)
+{
+	std::vector<double> weights(alphabet.size() + 1);
+	for (int i = 0; i < alphabet.size(); ++i)
+		weights[i] = 1.0 / (i + 1);
+	weights.back() = std::accumulate(std::begin(weights),
+		std::end(weights), 0.0) / 5;
+	std::discrete_distribution<int> distribution(std::begin(weights),
+		std::end(weights));
+	std::mt19937 generator(seed);
+
+	QString text(size, Qt::Uninitialized);
+	for (QChar& ch : text)
+	{
+		const int i = distribution(generator);
+		ch = (i < alphabet.size() ? alphabet[i] : QChar(' '));
+	}
+	return text;
+}
+
+// Runs job on consecutive slices of text in separate threads. Slices are
+// extended by overlap chars, so that n-grams on their borders are kept
+template<typename Result, typename Job>
+std::vector<Result> runSliced(QStringView text, int threads, int overlap,
+	const Job& job)
+{
+	std::vector<Result> results(threads);
+	auto runSlice = [&](int t) {
+		const int begin = (qint64)text.size() * t / threads;
+		const int end = (qint64)text.size() * (t + 1) / threads;
+		results[t] = job(text.mid(begin,
+			std::min(end + overlap, (int)text.size()) - begin));
+	};
+	if (threads == 1)
+		runSlice(0);
+	else
+	{
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; ++t)
+			workers.emplace_back(runSlice, t);
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+	return results;
+}
+
+TextStatistics::NGramCounts mergeCounts(
+	const std::vector<TextStatistics::NGramCounts>& parts)
+{
+	TextStatistics::NGramCounts merged = parts.front();
+	for (size_t i = 1; i < parts.size(); ++i)
+	{
+		for (auto it = parts[i].counts.begin(); it != parts[i].counts.end(); ++it)
+			merged.counts[it.key()] += it.value();
+		merged.total += parts[i].total;
+	}
+	return merged;
+}
+
+// Repeats operation until both repetition count and total time are reached
+template<typename Operation>
+Measurement measure(const Options& options, const Operation& operation)
+{
+	using Clock = std::chrono::steady_clock;
+	Measurement measurement;
+	double totalSeconds = 0;
+	while (measurement.repetitions < options.repetitions
+		|| totalSeconds < options.minSeconds)
+	{
+		const std::uint64_t allocations = AllocationCounter::allocations(),
+			allocatedBytes = AllocationCounter::allocatedBytes();
+		const auto start = Clock::now();
+		operation();
+		const double seconds = std::chrono::duration<double>(
+			Clock::now() - start).count();
+		if (measurement.repetitions == 0 || seconds < measurement.bestSeconds)
+			measurement.bestSeconds = seconds;
+		if (measurement.repetitions == 0)
+		{
+			measurement.operatorNewAllocations =
+				AllocationCounter::allocations() - allocations;
+			measurement.operatorNewBytes =
+				AllocationCounter::allocatedBytes() - allocatedBytes;
+		}
+		totalSeconds += seconds;
+		++measurement.repetitions;
+	}
+	measurement.meanSeconds = totalSeconds / measurement.repetitions;
+	return measurement;
+}
+
+QString resultKey(const QJsonObject& result)
+{
+	return QString("%1|%2|%3|%4").arg(result["operation"].toString(),
+		result["input"].toString()).arg(result["alphabetSize"].toInt())
+		.arg(result["threads"].toInt());
+}
+
+void runInput(const Options& options, const Input& input, QJsonArray& results)
+{
+	TextStatistics textStats;
+	if (!textStats.setAlphabet(input.alphabet, input.caseSensitive))
+	{
+		std::cerr << "Invalid alphabet for " << input.name.toStdString()
+			<< std::endl;
+		return;
+	}
+	const int m = input.alphabet.size();
+	int a = 3;
+	for (; std::gcd(a, m) != 1; ++a);
+	const int b = 7 % m;
+	const QString ciphertext = textStats.affineEncrypt(input.text, a, b);
+
+	auto report = [&](const QString& operation, int threads,
+		const Measurement& measurement) {
+		const double charsPerSecond = input.text.size()
+			/ std::max(measurement.bestSeconds, 1e-9);
+		QJsonObject result{
+			{ "operation", operation },
+			{ "input", input.name },
+			{ "alphabetSize", m },
+			{ "chars", input.text.size() },
+			{ "threads", threads },
+			{ "repetitions", measurement.repetitions },
+			{ "bestSeconds", measurement.bestSeconds },
+			{ "meanSeconds", measurement.meanSeconds },
+			{ "charsPerSecond", charsPerSecond },
+			{ "operatorNewAllocations",
+				(qint64)measurement.operatorNewAllocations },
+			{ "operatorNewBytes", (qint64)measurement.operatorNewBytes },
+			{ "peakMemoryBytes", (qint64)peakMemoryUsage() }
+		};
+		results.append(result);
+		std::cerr << resultKey(result).toStdString() << ": "
+			<< charsPerSecond << " chars/s" << std::endl;
+	};
+
+	for (int threads : options.threadCounts)
+	{
+		report("chars", threads, measure(options, [&]() {
+			runSliced<std::vector<int>>(input.text, threads, 0,
+				[&](QStringView slice) { return textStats.charCounts(slice); });
+		}));
+		report("bigrams", threads, measure(options, [&]() {
+			mergeCounts(runSliced<TextStatistics::NGramCounts>(
+				input.text, threads, 1, [&](QStringView slice) {
+				return textStats.bigramCounts(slice);
+			}));
+		}));
+		report("trigrams", threads, measure(options, [&]() {
+			mergeCounts(runSliced<TextStatistics::NGramCounts>(
+				input.text, threads, 2, [&](QStringView slice) {
+				return textStats.trigramCounts(slice);
+			}));
+		}));
+		report("encrypt", threads, measure(options, [&]() {
+			runSliced<QString>(input.text, threads, 0, [&](QStringView slice) {
+				return textStats.affineEncrypt(slice, a, b);
+			});
+		}));
+		report("decrypt", threads, measure(options, [&]() {
+			runSliced<QString>(ciphertext, threads, 0, [&](QStringView slice) {
+				return textStats.affineDecrypt(slice, a, b);
+			});
+		}));
+	}
+	// The attack is a sequence of dependent steps, so it's single-threaded
+	report("auto-decrypt", 1, measure(options, [&]() {
+		const auto key = textStats.findAffineKey(
+			textStats.twoMostFrequentChars(input.baseline),
+			textStats.twoMostFrequentChars(ciphertext));
+		if (key)
+			textStats.affineDecrypt(ciphertext, key->first, key->second);
+	}));
+}
+
+// Returns the number of results which are slower than in the baseline
+// by more than the tolerance
+int compareWithBaseline(const Options& options, const QJsonArray& results)
+{
+	QFile file(options.baselinePath);
+	file.open(QFile::ReadOnly);
+	if (!file.isOpen())
+	{
+		std::cerr << "Error reading baseline at: " << std::endl;
+		std::cerr << "  " << options.baselinePath.toStdString() << std::endl;
+		return -1;
+	}
+	QHash<QString, double> baselineSpeeds;
+	for (const QJsonValue& value :
+		QJsonDocument::fromJson(file.readAll())["results"].toArray())
+		baselineSpeeds[resultKey(value.toObject())] =
+			value["charsPerSecond"].toDouble();
+
+	int regressions = 0;
+	for (const QJsonValue& value : results)
+	{
+		const QString key = resultKey(value.toObject());
+		const auto it = baselineSpeeds.find(key);
+		if (it == baselineSpeeds.end())
+			continue;
+		const double ratio = value["charsPerSecond"].toDouble() / it.value();
+		if (ratio < 1 - options.tolerance)
+		{
+			std::cerr << "Regression in " << key.toStdString() << ": "
+				<< ratio * 100 << "% of baseline throughput" << std::endl;
+			++regressions;
+		}
+	}
+	return regressions;
+}
+
+// Value of a positive integer option, or 0 if it's invalid or exceeds max
+int positiveValue(const QString& value, int max)
+{
+	bool ok;
+	const qint64 result = value.toLongLong(&ok);
+	return ok && result > 0 && result <= max ? (int)result : 0;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (int i = 1; i < argc; ++i)
+	{
+		const bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "help") == 0)
+		{
+			std::cout << "Usage: " << std::endl;
+			std::cout << "<program> [<option> <value>...]" << std::endl;
+			std::cout << "  runs benchmarks of the analysis engine on bundled "
+				"corpora and synthetic texts and writes results as JSON. "
+				"Options:" << std::endl;
+			std::cout << "  --corpus <dir>       directory with 1.txt, 3.txt "
+				"and 3_colleague_encoded.txt" << std::endl;
+			std::cout << "  --max-size <chars>   size of the largest "
+				"synthetic text (" << MAX_SYNTHETIC_CHARS << " by default, "
+				"which is also the limit)" << std::endl;
+			std::cout << "  --threads <n,m,...>  thread counts to run with "
+				"(each at most " << MAX_THREADS << ")" << std::endl;
+			std::cout << "  --repeat <n>         minimum repetitions of "
+				"each measurement" << std::endl;
+			std::cout << "  --label <name>       name of the build to put "
+				"into results" << std::endl;
+			std::cout << "  --output <file>      file to write results to "
+				"instead of standard output" << std::endl;
+			std::cout << "  --baseline <file>    results of previous run to "
+				"check throughput against" << std::endl;
+			std::cout << "  --tolerance <ratio>  allowed throughput loss "
+				"against baseline (0.1 by default)" << std::endl;
+			return 0;
+		}
+		else if (std::strcmp(argv[i], "--corpus") == 0 && hasValue)
+			options.corpusDir = argv[++i];
+		else if (std::strcmp(argv[i], "--max-size") == 0 && hasValue)
+		{
+			if (!(options.maxSyntheticChars =
+				positiveValue(argv[++i], MAX_SYNTHETIC_CHARS)))
+			{
+				std::cerr << "Invalid size " << argv[i] << ", it should be "
+					"from 1 to " << MAX_SYNTHETIC_CHARS << ". See help."
+					<< std::endl;
+				return -1;
+			}
+		}
+		else if (std::strcmp(argv[i], "--threads") == 0 && hasValue)
+			for (const QString& count : QString(argv[++i]).split(','))
+			{
+				const int threads = positiveValue(count, MAX_THREADS);
+				if (threads == 0)
+				{
+					std::cerr << "Invalid thread count " << count.toStdString()
+						<< ", it should be from 1 to " << MAX_THREADS
+						<< ". See help." << std::endl;
+					return -1;
+				}
+				options.threadCounts.push_back(threads);
+			}
+		else if (std::strcmp(argv[i], "--repeat") == 0 && hasValue)
+		{
+			if (!(options.repetitions = positiveValue(argv[++i],
+				std::numeric_limits<int>::max())))
+			{
+				std::cerr << "Invalid repetition count " << argv[i]
+					<< ". See help." << std::endl;
+				return -1;
+			}
+		}
+		else if (std::strcmp(argv[i], "--label") == 0 && hasValue)
+			options.label = argv[++i];
+		else if (std::strcmp(argv[i], "--output") == 0 && hasValue)
+			options.outputPath = argv[++i];
+		else if (std::strcmp(argv[i], "--baseline") == 0 && hasValue)
+			options.baselinePath = argv[++i];
+		else if (std::strcmp(argv[i], "--tolerance") == 0 && hasValue)
+		{
+			bool ok;
+			options.tolerance = QString(argv[++i]).toDouble(&ok);
+			if (!ok || options.tolerance < 0)
+			{
+				std::cerr << "Invalid tolerance " << argv[i] << ". See help."
+					<< std::endl;
+				return -1;
+			}
+		}
+		else
+		{
+			std::cerr << "Unknown option " << argv[i] << ". See help."
+				<< std::endl;
+			return -1;
+		}
+	}
+	if (options.threadCounts.empty())
+	{
+		const int hardwareThreads = std::max(
+			(int)std::thread::hardware_concurrency(), 1);
+		for (int threads = 1; threads < hardwareThreads; threads *= 2)
+			options.threadCounts.push_back(threads);
+		options.threadCounts.push_back(hardwareThreads);
+	}
+
+	AllocationCounter::setEnabled(true);
+	QString baselineCorpus;
+	if (!readCorpus(options.corpusDir + "/1.txt", baselineCorpus))
+	{
+		std::cerr << "Error reading corpora at: " << std::endl;
+		std::cerr << "  " << options.corpusDir.toStdString() << std::endl;
+		return -1;
+	}
+
+	QFile output;
+	if (options.outputPath.isEmpty())
+		output.open(stdout, QFile::WriteOnly);
+	else
+	{
+		output.setFileName(options.outputPath);
+		output.open(QFile::WriteOnly);
+	}
+	if (!output.isOpen())
+	{
+		std::cerr << "Error writing results to: " << std::endl;
+		std::cerr << "  " << options.outputPath.toStdString() << std::endl;
+		return -1;
+	}
+	QString compiler;
+#ifdef _MSC_VER
+	compiler = QString("MSVC %1").arg(_MSC_FULL_VER);
+#elif defined(__VERSION__)
+	compiler = __VERSION__;
+#endif
+	QByteArray header = QJsonDocument(QJsonObject{
+		{ "label", options.label },
+		{ "compiler", compiler },
+		{ "qtVersion", qVersion() },
+		{ "hardwareThreads", (int)std::thread::hardware_concurrency() },
+		{ "allocationCounting", "partial, operator new only "
+			"(Qt strings and containers allocate with malloc)" }
+	}).toJson(QJsonDocument::Compact);
+	header.chop(1); // Report is closed after the results
+	output.write(header + ",\"results\":[\n");
+
+	// Results are written as soon as each input is done, so that the ones
+	// already measured survive a failure later in the run
+	QJsonArray results;
+	auto runAndWrite = [&](const Input& input) {
+		const int written = results.size();
+		runInput(options, input, results);
+		for (int i = written; i < results.size(); ++i)
+			output.write((i != 0 ? ",\n" : "") + QJsonDocument(
+				results[i].toObject()).toJson(QJsonDocument::Compact));
+		output.flush();
+	};
+	for (const char* name : { "1.txt", "3.txt", "3_colleague_encoded.txt" })
+	{
+		Input input{ name, UKRAINIAN_ALPHABET, false, "", baselineCorpus };
+		if (!readCorpus(options.corpusDir + "/" + name, input.text))
+		{
+			std::cerr << "Error reading corpus " << name << std::endl;
+			return -1;
+		}
+		runAndWrite(input);
+	}
+
+	// Synthetic texts are generated one at a time to limit memory usage.
+	// Their sizes grow by SYNTHETIC_SIZE_STEP, the last one is clamped to
+	// the maximum size
+	const std::vector<std::pair<QString, bool>> alphabets{
+		{ DIGITS_ALPHABET, false },
+		{ LATIN_ALPHABET, false },
+		{ UKRAINIAN_ALPHABET, false },
+		{ UKRAINIAN_ALPHABET + UKRAINIAN_ALPHABET.toUpper(), true }
+	};
+	for (qint64 step = MIN_SYNTHETIC_CHARS; ; step *= SYNTHETIC_SIZE_STEP)
+	{
+		const int size = (int)std::min<qint64>(step, options.maxSyntheticChars);
+		for (const auto& [alphabet, caseSensitive] : alphabets)
+			runAndWrite({ QString("synthetic-%1").arg(size), alphabet,
+				caseSensitive, syntheticText(alphabet, size, 1),
+				syntheticText(alphabet, BASELINE_CHARS, 2) });
+		if (size == options.maxSyntheticChars)
+			break;
+	}
+	output.write("\n]}\n");
+	output.close();
+
+	if (!options.baselinePath.isEmpty())
+	{
+		const int regressions = compareWithBaseline(options, results);
+		if (regressions != 0)
+			return regressions < 0 ? -1 : 1;
+	}
+	return 0;
+}